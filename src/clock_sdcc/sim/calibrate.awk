@@ -0,0 +1,14 @@
+# steps_per_half for stimulus.awk from the ucsim state printed at the end of a stimulus.awk run, run with awk -f calibrate.awk on the s51 output.
+# The instructions executed over the simulated time give the instructions in 250 ms. Nothing is printed and the exit is 1 when state is missing.
+/[Ii]nst exec since last reset/ { line = $0; sub(/.*= */, "", line); inst = line + 0 }
+/[Tt]otal time since last reset/ { line = $0; sub(/.*= */, "", line); time = line + 0 }
+
+END {
+  if(inst == 0 || time == 0)
+  {
+    print "calibrate.awk: no state from ucsim" > "/dev/stderr"
+    exit 1
+  }
+
+  printf "%d\n", inst * 0.25 / time + 0.5
+}
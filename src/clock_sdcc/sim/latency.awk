@@ -0,0 +1,191 @@
+# latency histograms from the vcd of a PROFILE=on run, run with awk -v target=<at89s51|at89s52> -f latency.awk <vcd>.
+# a: timer isr entry, from the P3.5 falling edge to the P2.7 (PROFILE_TIMER) rise.
+# b: control isr entry, P3.6 (PROFILE_CONTROL) rise. Shown above the smallest seen, the vector and prologue are the same every time.
+#    at89s51 reloads timer 0 in the isr so the latency is in the tick spacing, at89s52 auto-reloads so it is in the tick phase.
+# c: display refresh, from the control isr rise to the new digit value on P0 after the digit select on P2 moved.
+# first second, from the time set release (P3.3 rising) to the seconds LEDs on P1 first showing 1 second, should be 0.75 to 1.25 s.
+# the time to first display is from the start of the trace till a digit is first selected on P2, the flashing 00:00 at power up.
+# run times, the longest the control isr (P3.6) and the timer isr (P2.7) pins were high, in us which is machine cycles at 12 MHz.
+# The check fails (exit 1) when the 2 Hz falling edges in the trace are outside 475 to 525 ms, where START_SETTLE only ends at SETTLE_TIME, when no
+# time set release reached the seconds, then the run never left the power up flash and the histograms are meaningless, or when a first
+# second is outside 0.75 to 1.25 s.
+# brief=1 prints only the control and timer isr run times on one line, for make matrix.
+function bits(value,    n, i)
+{
+  n = 0
+  for(i = 2; i <= length(value); i++)
+  {
+    n = n * 2 + (substr(value, i, 1) == "1")
+  }
+  return n
+}
+
+function bit(value, b)
+{
+  return int(value / 2 ^ b) % 2
+}
+
+function record(hist, name, us)
+{
+  us = int(us + 0.5)
+  hist[name, (us > 255 ? 255 : us)]++
+  if(us > most[name]) most[name] = us
+  count[name]++
+}
+
+function report(hist, name, title, offset,    us)
+{
+  printf "%s, %d samples, max %d us\n", title, count[name], most[name] - offset
+  for(us = offset; us <= 255; us++)
+  {
+    if((name, us) in hist) printf "  %3d%s us %d\n", us - offset, (us == 255 ? "+" : " "), hist[name, us]
+  }
+}
+
+BEGIN {
+  scale = 1
+  tick_us = 1000
+}
+
+# timescale may be on the same line or the next one, turn it into microseconds per step.
+/\$timescale/ { in_scale = 1 }
+in_scale {
+  line = $0
+  gsub(/\$timescale|\$end/, "", line)
+  if(match(line, /[0-9]+ *[munpf]?s/))
+  {
+    unit = substr(line, RSTART, RLENGTH)
+    value = unit + 0
+    gsub(/[0-9 ]/, "", unit)
+    scale = value * (unit == "s" ? 1e6 : unit == "ms" ? 1e3 : unit == "us" ? 1 : unit == "ns" ? 1e-3 : unit == "ps" ? 1e-6 : 1e-9)
+  }
+  if($0 ~ /\$end/) in_scale = 0
+  next
+}
+
+$1 == "$var" { port[$4] = $5; next }
+
+/^#/ { now = substr($0, 2) * scale; next }
+
+/^b/ {
+  name = port[$2]
+  value = bits($1)
+
+  if(name == "P3")
+  {
+    # first second: time set let go.
+    if(!bit(p3, 3) && bit(value, 3)) set_release = now
+
+    # a: the falling edge of the 2 Hz input, only every other one overflows timer 1 so the rise must follow within a tick.
+    if(bit(p3, 5) && !bit(value, 5))
+    {
+      if(clock_last != "")
+      {
+        spacing = now - clock_last
+        if(edges == 0 || spacing < edge_min) edge_min = spacing
+        if(edges == 0 || spacing > edge_max) edge_max = spacing
+        edges++
+      }
+      clock_fall = now
+      clock_last = now
+    }
+
+    # run time of the control isr.
+    if(bit(p3, 6) && !bit(value, 6) && control_rise != "" && now - control_rise > control_run) control_run = now - control_rise
+
+    # b and c: the control isr rises.
+    if(!bit(p3, 6) && bit(value, 6))
+    {
+      if(target == "at89s52")
+      {
+        if(first == "") first = now
+        control = (now - first) % tick_us
+      }
+      else
+      {
+        control = (last == "" ? "" : now - last - tick_us)
+        last = now
+      }
+
+      if(control != "")
+      {
+        record(hist, "b", control)
+        if(least == "" || int(control + 0.5) < least) least = int(control + 0.5)
+      }
+
+      if(tick == "") tick = now
+      control_rise = now
+    }
+  }
+
+  if(name == "P2")
+  {
+    if(first_display == "" && (value % 16) != 0) first_display = now
+
+    if(!bit(p2, 7) && bit(value, 7) && clock_fall != "" && now - clock_fall < tick_us)
+    {
+      record(hist, "a", now - clock_fall)
+      clock_fall = ""
+    }
+
+    if((value % 16) != (p2 % 16)) moved = 1
+
+    # run time of the timer isr.
+    if(!bit(p2, 7) && bit(value, 7)) timer_rise = now
+    if(bit(p2, 7) && !bit(value, 7) && timer_rise != "" && now - timer_rise > timer_run) timer_run = now - timer_rise
+  }
+
+  # first second: the seconds LEDs are complimented, 1 second shows as 0x3E.
+  if(name == "P1" && set_release != "" && (value % 64) == 62)
+  {
+    us = now - set_release
+    if(firsts == 0 || us < first_min) first_min = us
+    if(firsts == 0 || us > first_max) first_max = us
+    firsts++
+    set_release = ""
+  }
+
+  if(name == "P0" && value != 0 && moved && tick != "")
+  {
+    record(hist, "c", now - tick)
+    tick = ""
+    moved = 0
+  }
+
+  if(name == "P3") p3 = value
+  if(name == "P2") p2 = value
+}
+
+END {
+  bad = 0
+  if(edges == 0 || edge_min < 475000 || edge_max > 525000)
+  {
+    printf "FAIL: 2 Hz falling edges %d to %d ms apart, outside 475 to 525 ms. Check the steps_per_half calibration.\n", int(edge_min / 1000 + 0.5), int(edge_max / 1000 + 0.5) > "/dev/stderr"
+    bad = 1
+  }
+  if(firsts == 0)
+  {
+    print "FAIL: no time set release reached the seconds, the run stayed in the power up flash." > "/dev/stderr"
+    bad = 1
+  }
+  else if(first_min < 750000 || first_max > 1250000)
+  {
+    printf "FAIL: first second after time set %d to %d ms, outside 750 to 1250 ms.\n", int(first_min / 1000 + 0.5), int(first_max / 1000 + 0.5) > "/dev/stderr"
+    bad = 1
+  }
+
+  if(brief)
+  {
+    printf "%d %d\n", int(control_run + 0.5), int(timer_run + 0.5)
+    exit bad
+  }
+
+  printf "2 Hz falling edge spacing, %d samples, min %d ms, max %d ms\n", edges, int(edge_min / 1000 + 0.5), int(edge_max / 1000 + 0.5)
+  printf "longest run, control isr %d us, timer isr %d us\n", int(control_run + 0.5), int(timer_run + 0.5)
+  printf "time to first display %s us\n", (first_display == "" ? "-" : int(first_display + 0.5))
+  printf "first second after time set, %d samples, min %d ms, max %d ms\n", firsts, int(first_min / 1000 + 0.5), int(first_max / 1000 + 0.5)
+  report(hist, "a", "a: timer isr entry latency", 0)
+  report(hist, "b", "b: control isr entry latency above the smallest", least)
+  report(hist, "c", "c: tick to new digit on P0", 0)
+  exit bad
+}
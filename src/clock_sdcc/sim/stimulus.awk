@@ -0,0 +1,73 @@
+# ucsim command stream, run with awk -v vcd=<file> -v seconds=<n> -v seed=<n> -v steps_per_half=<n> -f stimulus.awk.
+# Drives the 2 Hz clock on P3.5 (timer 1 input) and switch presses on P3.0 to P3.4, while the vcd module records P0 to P3 when vcd is given.
+# Time is stepped in instructions, steps_per_half is the instructions in 250 ms (half a 2 Hz period). The firmware mostly idles so it is
+# measured with calibrate.awk rather than worked out, START_SETTLE only passes before SETTLE_TIME when the edges are within 5% of 500 ms.
+# Time set is pressed 3 seconds in, once the 2 Hz clock has settled, so the firmware leaves the power up flash.
+# A random switch is then pressed about once a minute, switches change part way into a half second so a time set release lands at any
+# phase of the 2 Hz clock. state is printed before quitting.
+function pins()
+{
+  # P3.6 and P3.7 are the profiling outputs, left high. awk has no hex constants.
+  printf "set hw port[3] pin 0x%02x\n", 192 + (clock ? 32 : 0) + (31 - press)
+}
+
+BEGIN {
+  if(seconds == "") seconds = 86400
+  if(seed == "") seed = 1
+  if(steps_per_half == "") steps_per_half = 125000
+
+  srand(seed)
+
+  if(vcd != "")
+  {
+    print "set hw vcd[0] file \"" vcd "\""
+    print "set hw vcd[0] add P0"
+    print "set hw vcd[0] add P1"
+    print "set hw vcd[0] add P2"
+    print "set hw vcd[0] add P3"
+    print "set hw vcd[0] start"
+  }
+
+  # switches idle high, pressed is low. clock is the P3.5 level.
+  clock = 1
+  press = 0
+  hold  = 0
+
+  for(half = 0; half < seconds * 4; half++)
+  {
+    clock = !clock
+    pins()
+
+    part = int(steps_per_half / 2)
+
+    # a held switch is let go after its hold time. Time set (8) for 1 second at 3 seconds in.
+    if(hold > 0)
+    {
+      hold--
+      if(hold == 0) press = 0
+    }
+    else if(half == 12)
+    {
+      press = 8
+      hold  = 4
+    }
+    else
+    {
+      part = 1 + int(rand() * (steps_per_half - 1))
+
+      if(rand() < 1 / 240)
+      {
+        press = 2 ^ int(rand() * 5)
+        hold  = 1 + int(rand() * 8)
+      }
+    }
+
+    print "step " part
+    pins()
+    print "step " (steps_per_half - part)
+  }
+
+  if(vcd != "") print "set hw vcd[0] stop"
+  print "state"
+  print "quit"
+}
@@ -7,9 +7,9 @@
 ///           extension mod, need many instruction cycles to complete.
 ///           Ifs and compares are usually faster but not as clean. For such
 ///           a low resource micro-controller a bit more code space was preferred
-///           vs longer execution time. In addition, the decision to to have so
-///           much code in the ISRs is ill-advised. In this case with careful
-///           testing this operates well and doesn't present a problem.
+///           vs longer execution time. The ISRs only keep the tick and the
+///           seconds and set event bits, main runs the rest as tasks from a
+///           priority ordered table so the interrupt paths stay short.
 ///
 /// @copyright Copyright 2022 Johnathan Convertino
 ///
@@ -34,8 +34,13 @@
 /// IN THE SOFTWARE.
 //*****************************************************************************
 
-/// @brief ATMEGA 89s51 specific header, has a 3rd timer.
+#ifdef TARGET_AT89S52
+/// @brief ATMEL 89s52 specific header, has a 3rd timer (Timer 2) used for the millisecond tick.
+#include <at89x52.h>
+#else
+/// @brief ATMEL 89s51 specific header, Timer 0 and Timer 1 only.
 #include <at89x51.h>
+#endif
 /// @brief standard int for uints
 #include <stdint.h>
 
@@ -44,10 +49,24 @@
 /// @def Timer 1 low reg for 12 MHz milliseconds count
 #define TL0_START 0x18
 
+#ifdef TARGET_AT89S52
+/// @def TICK_VECTOR millisecond tick interrupt, Timer 2 reloads itself from RCAP2H/RCAP2L so there is no software reload drift.
+#define TICK_VECTOR   TF2_VECTOR
+/// @def TICK_ENABLE millisecond tick interrupt enable.
+#define TICK_ENABLE   ET2
+#else
+/// @def TICK_VECTOR millisecond tick interrupt, Timer 0 is reloaded in software.
+#define TICK_VECTOR   TF0_VECTOR
+/// @def TICK_ENABLE millisecond tick interrupt enable.
+#define TICK_ENABLE   ET0
+#endif
+
 /// @def Timer 1 high reg for 2 Hz clock divide by 2 for seconds.
 #define TH1_START 0xFF
 /// @def Timer 1 low reg for 2 Hz clock divide by 2 for seconds.
 #define TL1_START 0xFE
+/// @def Timer 1 low reg for a first second of 3 half seconds, when time set is let go late in a half second.
+#define TL1_LATE  0xFD
 
 /// @def ON is binary 1
 #define ON  1
@@ -68,6 +87,24 @@
 /// @def Clock display LED for alarm on/off transistor input.
 #define ALARM_LED     P1_7
 
+#ifdef PROFILE
+/// @def PROFILE_CONTROL spare pin (P3.6, not connected) that is high while the control isr runs. Build with make PROFILE=on.
+#define PROFILE_CONTROL P3_6
+/// @def PROFILE_DISPLAY spare pin (P3.7, not connected) that is high while the display task updates the ports.
+#define PROFILE_DISPLAY P3_7
+/// @def PROFILE_TIMER spare pin (P2.7, not connected) that is high while the timer isr runs. P2 is only written by main, so the isr edges are never lost.
+#define PROFILE_TIMER   P2_7
+/// @def PROFILE_ON set a profiling pin on entry to the profiled code.
+#define PROFILE_ON(pin)  pin = 1
+/// @def PROFILE_OFF clear a profiling pin on exit from the profiled code.
+#define PROFILE_OFF(pin) pin = 0
+#else
+/// @def PROFILE_ON profiling is off, no code.
+#define PROFILE_ON(pin)
+/// @def PROFILE_OFF profiling is off, no code.
+#define PROFILE_OFF(pin)
+#endif
+
 /// @def Switch alarm set location.
 #define SET_A_SWITCH  P3_4
 /// @def Switch time set location.
@@ -79,18 +116,233 @@
 /// @def Switch alarm on/off location.
 #define ALARM_SWITCH  P3_2
 
-/// @def MIN_DELAY minimum delay for switch press.
-#define MIN_DELAY     75
-/// @def INIT_DELAY initial delay for switch press when setting time.
-#define INIT_DELAY    125
-/// @def RAMP_DELAY ramp for initial delay to decrease with time to speed up time set when held.
-#define RAMP_DELAY    5
-/// @def TONE_TIME time for tone to stay activated in milliseconds before next tone.
-#define TONE_TIME     250
+/// @def Switch hour increment bit in P3 and in the debounced switch bytes.
+#define SW_HOUR       0x01
+/// @def Switch minute increment bit in P3 and in the debounced switch bytes.
+#define SW_MINUTE     0x02
+/// @def Switch alarm on/off bit in P3 and in the debounced switch bytes.
+#define SW_ALARM      0x04
+/// @def Switch time set bit in P3 and in the debounced switch bytes.
+#define SW_SET_T      0x08
+/// @def Switch alarm set bit in P3 and in the debounced switch bytes.
+#define SW_SET_A      0x10
+/// @def Mask of all switch bits in P3, P3.5 is the 2 Hz counter input and is left out.
+#define SW_MASK       0x1F
+
+/// @def SCAN_TIME time between switch scans and timer wheel ticks in milliseconds, the delays below are in scans.
+#define SCAN_TIME     10
+/// @def SCAN_BURST number of scans to keep scanning after the last switch activity, 2 seconds.
+#define SCAN_BURST    200
+/// @def TIMER_SLOTS number of slots in the timer wheel, one per scan, must be a power of 2. The AT89S51 has half the slots to save ram, long timers just take more trips round.
+#ifdef TARGET_AT89S52
+#define TIMER_SLOTS   8
+#else
+#define TIMER_SLOTS   4
+#endif
+/// @def TIMER_MASK mask to wrap timer wheel indexes.
+#define TIMER_MASK    (TIMER_SLOTS - 1)
+/// @def TIMER_COUNT number of timers, each one owns an event bit in the timer wheel.
+#define TIMER_COUNT   4
+/// @def TIMER_TONE timer for the current alarm pattern step.
+#define TIMER_TONE    0
+/// @def TIMER_REPEAT timer for hour and minute autorepeat.
+#define TIMER_REPEAT  1
+/// @def TIMER_HOLD timer for the alarm on/off switch long hold in alarm set.
+#define TIMER_HOLD    2
+/// @def TIMER_ALARM timer for how long the alarm sounds.
+#define TIMER_ALARM   3
+/// @def ALARM_TIME scans the alarm sounds for, 59 seconds.
+#define ALARM_TIME    5900
+/// @def EDGE_HALF scans after a 2 Hz falling edge past which time set was let go late, halfway to the next edge (250 ms, 25 scans) plus the 4 scan (40 ms) debounce.
+#define EDGE_HALF     29
+/// @def START_SETTLE power up state, flashing 00:00 while the 2 Hz clock edge spacing is checked.
+#define START_SETTLE  0
+/// @def START_FLASH power up state, the 2 Hz clock is stable or SETTLE_TIME has passed and 00:00 flashes with the seconds till time set is pressed.
+#define START_FLASH   1
+/// @def EDGE_MIN shortest 2 Hz falling edge spacing in milliseconds that counts as stable.
+#define EDGE_MIN      475
+/// @def EDGE_MAX longest 2 Hz falling edge spacing in milliseconds that counts as stable.
+#define EDGE_MAX      525
+/// @def START_EDGES in range edge spacings in a row before the 2 Hz clock is stable.
+#define START_EDGES   2
+/// @def SETTLE_TIME milliseconds the 2 Hz clock has to settle in before 00:00 flashes with the seconds anyway, so a 2 Hz clock out of range or stopped still lets the time be set.
+#define SETTLE_TIME   3000
+/// @def FLASH_TIME milliseconds for one on/off flash while settling, the same as a second.
+#define FLASH_TIME    1000
+/// @def ALARM_SLOTS number of alarms that can be set, must be a power of 2. The AT89S51 only has ram for 2.
+#ifdef TARGET_AT89S52
+#define ALARM_SLOTS   4
+#else
+#define ALARM_SLOTS   2
+#endif
+/// @def ALARM_HOLD scans the alarm on/off switch is held in alarm set to turn the shown alarm on or off, 1 second.
+#define ALARM_HOLD    100
+/// @def SNOOZE_MINUTES minutes till a snoozed alarm sounds again.
+#define SNOOZE_MINUTES 9
+/// @def SW_SNOOZE switches that snooze a sounding alarm. Time set is left out since holding it stops the seconds.
+#define SW_SNOOZE     (SW_HOUR | SW_MINUTE | SW_ALARM | SW_SET_A)
+/// @def SW_STATS switches held together outside of time and alarm set to show the isr timing stats.
+#define SW_STATS      (SW_HOUR | SW_MINUTE)
+/// @def STATS_PAGES number of isr timing stats pages, max control isr latency, control isr overruns and timer isr preemptions.
+#define STATS_PAGES   3
+/// @def SW_DATE switch held on its own to show the date, day and month with the weekday on the seconds LEDs.
+#define SW_DATE       SW_MINUTE
+/// @def SW_YEAR switch held on its own to show the year.
+#define SW_YEAR       SW_HOUR
+/// @def SW_SET_DATE switches held together to set the date, hour steps the month (and year past 12) and minute steps the day.
+#define SW_SET_DATE   (SW_SET_A | SW_SET_T)
+/// @def SHOW_TIME the time frame shows the time.
+#define SHOW_TIME     0
+/// @def SHOW_STATS the time frame shows the isr timing stats.
+#define SHOW_STATS    1
+/// @def SHOW_DATE the time frame shows the day and month.
+#define SHOW_DATE     2
+/// @def SHOW_YEAR the time frame shows the year.
+#define SHOW_YEAR     3
+/// @def MINUTES_PER_DAY minutes in a day, the range of the minute of the day.
+#define MINUTES_PER_DAY 1440
+/// @def NO_ALARM minute of the day that never matches, used when no alarm is enabled.
+#define NO_ALARM      0xFFFF
+/// @def ALARM_PATTERN index into patternArray of the alarm pattern to play, set from the makefile per clock.
+#ifndef ALARM_PATTERN
+#define ALARM_PATTERN 0
+#endif
+#if (ALARM_PATTERN < 0) || (ALARM_PATTERN > 3)
+#error "ALARM_PATTERN must be 0 to 3, one per patternArray entry"
+#endif
+/// @def DST_RULES index into dstSetArray of the daylight saving rules to follow, 0 is none, 1 is US, 2 is EU. Set from the makefile per clock.
+#ifndef DST_RULES
+#define DST_RULES     0
+#endif
+#if (DST_RULES < 0) || (DST_RULES > 2)
+#error "DST_RULES must be 0 (none), 1 (US) or 2 (EU), one per dstSetArray entry"
+#endif
+/// @def DST_LAST week of a rule for the last of its weekday in the month.
+#define DST_LAST      5
+/// @def DST_SUNDAY weekday of a rule for Sunday, weekday 0 is Monday.
+#define DST_SUNDAY    6
+
+/// @def RAM_AT place a variable at a fixed address below DATA_LOC (0x30) on the AT89S51, its 80 bytes above that are left for the rest of the data, idata and the stack.
+///      Register banks 2 and 3 (0x10 to 0x1F) hold the kept state, 0x22 to 0x2E the frames and stats. 0x20 and 0x21 stay free for the __bit variables. The AT89S52 leaves it to the linker.
+#ifdef TARGET_AT89S52
+#define RAM_AT(addr)
+#else
+#define RAM_AT(addr)  __at (addr)
+#endif
+/// @def CONTROL_USING register bank of the millisecond and switch isrs. NO_BANKS builds them without banks, make matrix runs it to measure what the banks save in the prologues.
+/// @def TIMER_USING register bank of the seconds isr. On the AT89S51 bank 2 holds data, the isr saves the few registers it uses instead.
+#ifdef NO_BANKS
+#define CONTROL_USING
+#define TIMER_USING
+#elif defined(TARGET_AT89S52)
+#define CONTROL_USING __using (1)
+#define TIMER_USING   __using (2)
+#else
+#define CONTROL_USING __using (1)
+#define TIMER_USING
+#endif
+/// @def EVENT_BYTE address of the task event byte, the last byte of bit addressable ram so the compiler's own bits from 0x20 up do not overlap it.
+#define EVENT_BYTE    0x2F
+/// @def EVENT_BITS bit address of bit 0 of the task event byte.
+#define EVENT_BITS    0x78
+/// @def EVENT_MINUTE event bit for a minute passed, set by the timer isr. The event bits are in task priority order, lowest bit first.
+#define EVENT_MINUTE  0x01
+/// @def EVENT_SECOND event bit for a second passed, set by the timer isr.
+#define EVENT_SECOND  0x02
+/// @def EVENT_INPUT event bit for a switch edge on INT0 or INT1, set by the switch isrs.
+#define EVENT_INPUT   0x04
+/// @def EVENT_SCAN event bit for a switch scan and timer wheel tick due, set by the control isr every SCAN_TIME milliseconds.
+#define EVENT_SCAN    0x08
+/// @def EVENT_TIME event bit for the current time changed and its frame needs rendering, set by main.
+#define EVENT_TIME    0x10
+/// @def EVENT_ALARM event bit for an alarm time or enable changed, set by main.
+#define EVENT_ALARM   0x20
+/// @def EVENT_TICK event bit for a millisecond passed, set by the control isr.
+#define EVENT_TICK    0x40
+/// @def TASK_COUNT number of tasks in taskArray.
+#define TASK_COUNT    7
+/// @def WDTRST_ADDR address of the watchdog reset register, write 0x1E then 0xE1 to start or feed it. It resets the cpu after 16384 machine cycles, 16 ms.
+#define WDTRST_ADDR   0xA6
+/// @def SECOND_DEADLINE scans the seconds path has to check in by before the watchdog is starved, 2.5 seconds. The first second after a time set release can take up to 2 seconds to come round.
+#define SECOND_DEADLINE 250
+/// @def WARM_MAGIC value of warmMagic while the kept state in ram is good, anything else at reset is a cold start. warmCheck must match too.
+#define WARM_MAGIC    0xA55A
+
+/// @brief watchdog reset register of the 89s51 and 89s52.
+__sfr __at (WDTRST_ADDR) WDT_RST;
 
 /// @brief 7 segment lookup table A=0,B=1,C=2,D=3,E=4,F=5,G=6
 const uint8_t segmentArray[] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
 
+/// @brief bit lookup table, converts an index to its bit to avoid variable shifts.
+const uint8_t bitArray[] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+
+/// @brief digit select lookup table, indexed by digitSelect in the same order as the frames.
+const uint8_t digitArray[] = {SEG_ONE_MINUTE, SEG_TEN_MINUTE, SEG_ONE_HOUR, SEG_TEN_HOUR};
+
+/// @def Struct to hold one stage of the hour/minute autorepeat acceleration.
+struct repeat
+{
+  uint8_t delay;
+  uint8_t count;
+  uint8_t minutes;
+};
+
+/// @brief autorepeat acceleration table for setting time and alarm. {delay in scans before the next step, steps before moving to the next stage (0 is forever), minutes per minute step}.
+const struct repeat repeatArray[] = {{30, 1, 1}, {12, 10, 1}, {7, 40, 1}, {10, 0, 10}};
+
+/// @def Struct to hold one step of an alarm pattern, channel 0 is a rest.
+struct tone
+{
+  uint8_t channel;
+  uint8_t duration;
+};
+
+/// @brief alarm pattern table of {4051 channel, duration in scans}, a duration of 0 ends a pattern and it starts over.
+const struct tone toneArray[] = {
+  // 0: falling sweep through all channels, the original alarm.
+  {7, 25}, {6, 25}, {5, 25}, {4, 25}, {3, 25}, {2, 25}, {1, 25}, {0, 0},
+  // 1: double beep.
+  {4, 10}, {0, 5}, {4, 10}, {0, 50}, {0, 0},
+  // 2: rising triplet.
+  {1, 15}, {3, 15}, {5, 15}, {0, 40}, {0, 0},
+  // 3: slow pulse.
+  {6, 50}, {0, 50}, {0, 0}
+};
+
+/// @brief start index in toneArray of each alarm pattern.
+const uint8_t patternArray[] = {0, 8, 13, 18};
+
+/// @brief days in each month, index 1 is January. February gains a day in leap years.
+const uint8_t monthArray[] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+/// @def Struct to hold one daylight saving rule, the nth weekday of the month at a minute of the local day. Forward ON moves the clock on an hour, OFF back an hour.
+struct dst_rule
+{
+  uint8_t  month;
+  uint8_t  week;
+  uint8_t  weekday;
+  uint16_t minute;
+  uint8_t  forward;
+};
+
+/// @brief daylight saving rule sets in month order, each ends with a month 0 entry. Rule minutes stay between 01:00 and 22:59 so a shift never crosses midnight.
+const struct dst_rule dstArray[] = {
+  // none
+  {0,  0,        0,          0,   OFF},
+  // US, second Sunday of March and first Sunday of November at 02:00.
+  {3,  2,        DST_SUNDAY, 120, ON},
+  {11, 1,        DST_SUNDAY, 120, OFF},
+  {0,  0,        0,          0,   OFF},
+  // EU, last Sunday of March at 02:00 and of October at 03:00 (CET).
+  {3,  DST_LAST, DST_SUNDAY, 120, ON},
+  {10, DST_LAST, DST_SUNDAY, 180, OFF},
+  {0,  0,        0,          0,   OFF}
+};
+
+/// @brief start index in dstArray of each rule set.
+const uint8_t dstSetArray[] = {0, 1, 4};
+
 /// @def Sturct to hold time elements for alarm and current time.
 struct time
 {
@@ -100,47 +352,310 @@ struct time
   uint8_t ten_hours;
 };
 
-/// @brief Global variable for digit selection.
-volatile uint8_t  digitSelect   = 1;
-/// @brief Global variable to keep count of the number of milliseconds a switch is pressed.
-volatile uint8_t  switchTimeout = 0;
-/// @brief Global variable to hold the initial time that is reduced by ramp_delay.
-volatile uint8_t  initTimeout   = INIT_DELAY;
-/// @brief Global variable to hold the number of milliseconds passed.
-volatile uint16_t milliseconds  = 0;
-/// @brief Global variable to hold the number of previous milliseconds passed.
-volatile uint16_t prev_milliseconds  = 0;
-/// @brief Global variable to hold the number of seconds passed.
-volatile uint8_t  seconds       = 0;
-/// @brief Global struct to hold the current time.
-volatile struct   time gs_timeKeeper = {0,0,0,0};
-/// @brief Global struct to hold the current alarm set time
-volatile struct   time gs_alarmKeeper = {0,0,0,0};
-/// @brief Global variable to tell if the alarm is on.
-volatile uint8_t  alarm_on_off        = OFF;
+/// @def Struct to hold the date, year is from 2000 (0 to 99) so every 4th year is a leap year. Weekday 0 is Monday.
+struct date
+{
+  uint8_t day;
+  uint8_t month;
+  uint8_t year;
+  uint8_t weekday;
+};
+
+/// @brief Global variable set to WARM_MAGIC once the time has been set, so a reset that leaves ram alone (watchdog) keeps the time and alarms. Cleared by the C startup on a cold start, and by feedWatchdog once the seconds path stops.
+__data RAM_AT(0x1A) uint16_t warmMagic;
+/// @brief Global variable for the checksum of the kept state, from warmChecksum. Updated by keepState whenever the time or alarms change.
+__data RAM_AT(0x1C) uint8_t  warmCheck;
+/// @brief Global variable for the scans left for the seconds path to check in, the watchdog is starved at 0.
+__data RAM_AT(0x2E) uint8_t  secondTimeout;
+/// @brief Global variable to tell if the display task has run since the watchdog was last fed.
+__bit    display_alive;
+/// @brief Global variable for the timer 1 count at the last scan, it moves on each 2 Hz falling edge.
+uint8_t  edgeCount;
+/// @brief Global variable for the scans since the last 2 Hz falling edge, stops at 255.
+uint8_t  edgeAge;
+/// @brief Global variable for digit selection, index into digitArray and the frames (0 to 3). Moved on by the display task.
+__data uint8_t  digitSelect;
+/// @brief Global variable for bit 0 of the per switch vertical debounce counters.
+__data uint8_t  sw_count0;
+/// @brief Global variable for bit 1 of the per switch vertical debounce counters.
+__data uint8_t  sw_count1;
+/// @brief Global variable for the debounced switch state in the scan task, 1 is held. Uses the SW_ bits.
+__data uint8_t  sw_state;
+/// @brief Global variable for the switch state switchEvent has applied, 1 is held. Uses the SW_ bits.
+uint8_t  sw_held;
+/// @brief Global variable to hold the current stage of the autorepeat acceleration, index into repeatArray.
+uint8_t  repeatStage;
+/// @brief Global variable to keep count of the steps made in the current autorepeat stage.
+uint8_t  repeatCount;
+/// @brief Global variable to keep count of the number of milliseconds till the next scan.
+volatile __data uint8_t  scanTimeout;
+/// @brief Global variable to keep count of the scans left in the current burst, switches are not scanned at 0.
+__data uint8_t  scanBurst;
+/// @brief Global timer wheel, each slot holds the event bits of the timers that expire on that scan.
+__idata uint8_t timerWheel[TIMER_SLOTS];
+/// @brief Global variable for the timer wheel slot of the last scan.
+__data uint8_t  timerPos;
+/// @brief Global variable with the event bits of expired timers, set by moveTimers and cleared by pollTimers.
+__data uint8_t  timerEvents;
+/// @brief Global array of scans left for each timer after its current trip round the wheel.
+__idata uint16_t timerRemain[TIMER_COUNT];
+/// @brief Global variable for the next step to play in toneArray.
+uint8_t  toneStep;
+/// @brief Global variable to hold the number of seconds passed, counted by the timer isr. Kept over a warm restart.
+volatile __data RAM_AT(0x1E) uint8_t  seconds;
+/// @brief Global struct to hold the current time, kept by the minute task. Kept over a warm restart.
+__data RAM_AT(0x10) struct time gs_timeKeeper;
+/// @brief Global struct to hold the date, moved on by the minute task at midnight. Kept over a warm restart.
+__data RAM_AT(0x14) struct date gs_date;
+/// @brief Global struct array to hold the alarm set times, one per alarm slot. Kept over a warm restart.
+volatile __idata struct time gs_alarmKeeper[ALARM_SLOTS];
+/// @brief Global variable to hold the current time as minutes since midnight, kept with gs_timeKeeper. Kept over a warm restart.
+__data RAM_AT(0x18) uint16_t minuteOfDay;
+/// @brief Global variable to hold the minute of the day of the next enabled alarm, or NO_ALARM.
+uint16_t nextAlarm;
+/// @brief Global variable to hold the minute of the day a snoozed alarm sounds again, or NO_ALARM.
+uint16_t snoozeAlarm;
+/// @brief Global variable for the alarm slot shown and edited in alarm set.
+uint8_t  alarmSlot;
+/// @brief Global variable with one enable bit per alarm slot, slot 0 is on by default. Kept over a warm restart.
+__data RAM_AT(0x1D) uint8_t  alarmEnable;
+/// @brief Global variable to tell if a short press of the alarm on/off switch in alarm set is still pending, ON till the hold timer expires.
+__bit    alarmHold;
+/// @brief Global variable for the seconds LEDs in alarm set, one LED for the alarm slot and the top LED when it is enabled. 0 is on.
+uint8_t  alarmLeds;
+/// @brief Global variable for the largest control isr entry latency seen, in microseconds. 255 means 255 or more.
+volatile __data RAM_AT(0x2A) uint8_t maxLatency;
+/// @brief Global variable to count the control isr runs that went past the next tick, stops at 255.
+volatile __data RAM_AT(0x2B) uint8_t overrunCount;
+/// @brief Global variable to count the timer isr runs that preempted the control isr, stops at 255.
+volatile __data RAM_AT(0x2C) uint8_t preemptCount;
+/// @brief Global variable for the isr timing stats page shown, 1 to STATS_PAGES, moves on with each new press of SW_STATS.
+__data RAM_AT(0x2D) uint8_t  statsPage;
+/// @brief Global variable for what the time frame shows, SHOW_TIME, SHOW_STATS, SHOW_DATE or SHOW_YEAR.
+__data RAM_AT(0x1F) uint8_t  timeShow;
+/// @brief Global variable to tell the timer isr the control isr is running, so a preemption can be counted.
+volatile __bit control_busy;
+/// @brief Global variable to tell if the alarm is on. Kept over a warm restart.
+volatile __bit alarm_on_off;
+/// @brief Global variable to tell if daylight saving time is in effect. Kept over a warm restart.
+__bit    dst_on;
+/// @brief Global variable to tell if the date has been set since the last cold start, daylight saving only follows a set date. Kept over a warm restart.
+__bit    date_set;
+/// @brief Global variable to tell if the date is being set, ON once both set switches are held and OFF again only when both are released, whichever goes first.
+volatile __bit date_edit;
+/// @brief Global variable to hold the minute of today's daylight saving shift, or NO_ALARM. Found once a day so the minute task only checks it.
+uint16_t dstMinute;
+/// @brief Global variable to tell if the alarm is sounding, the alarm pattern plays while it is ON.
+volatile __bit alarm_sounding;
 /// @brief Global variable to store the current tone set from clock divider to 4051 router.
-volatile uint8_t  alarm_tone          = 0;
+volatile uint8_t  alarm_tone;
+/// @brief Global byte of task event bits in bit addressable ram. The isrs only set single bits, main takes the whole byte with interrupts off.
+volatile __data __at (EVENT_BYTE) uint8_t taskEvents;
+/// @brief Global variable to tell main the minute changed, the time is advanced and the alarms checked.
+volatile __bit __at (EVENT_BITS + 0) minute_changed;
+/// @brief Global variable to tell main the second changed, the seconds path checks in with the watchdog.
+volatile __bit __at (EVENT_BITS + 1) second_changed;
+/// @brief Global variable to tell main a switch edge was seen on INT0 or INT1 and a scan burst should start.
+volatile __bit __at (EVENT_BITS + 2) input_ready;
+/// @brief Global variable to tell main a switch scan and timer wheel tick is due.
+volatile __bit __at (EVENT_BITS + 3) scan_ready;
+/// @brief Global variable to tell main the current time changed and its frame needs to be rendered.
+volatile __bit __at (EVENT_BITS + 4) time_changed;
+/// @brief Global variable to tell main the alarm time changed and its frame needs to be rendered.
+volatile __bit __at (EVENT_BITS + 5) alarm_changed;
+/// @brief Global variable to tell main a millisecond passed and the display moves on a digit.
+volatile __bit __at (EVENT_BITS + 6) tick_ready;
+/// @brief Global array of 7 segment values rendered from the current time, one per digit.
+__idata RAM_AT(0x22) uint8_t timeFrame[4];
+/// @brief Global array of 7 segment values rendered from the alarm time, one per digit.
+__idata RAM_AT(0x26) uint8_t alarmFrame[4];
+
+/// @brief function called by the C startup before ram is cleared, a non zero return skips the clear and all initializers.
+unsigned char _sdcc_external_startup(void);
+
+/// @brief function to set all runtime state, the initializers are skipped on a warm restart so nothing relies on them.
+void initState(void);
+
+/// @brief function to checksum the state kept over a warm restart, everything but seconds which changes in the timer isr.
+uint8_t warmChecksum(void);
+
+/// @brief function to update warmCheck after the kept state changes.
+void keepState(void);
+
+/// @brief function to feed the watchdog if the tick, the seconds path and the display have all checked in.
+void feedWatchdog(void);
 
 /// @brief function to flash clock at 00:00 on/off per second till time set pressed. Indicates power outage and the clock needs to be set.
 inline void waitForTimeSet();
 
+/// @brief function to render a time struct into a frame of 7 segment values in digitArray order.
+void renderFrame(uint8_t *p_frame, volatile struct time *p_time);
+
+/// @brief function to render the shown isr timing stats page into a frame, the page number and a 3 digit value.
+void renderStats(uint8_t *p_frame);
+
+/// @brief function to render the date or year into a frame.
+void renderDate(uint8_t *p_frame);
+
+/// @brief function to render a value from 0 to 99 into two digits of a frame, ones first.
+void renderTwo(uint8_t *p_digits, uint8_t value);
+
+/// @brief function to get the days in a month of the current year.
+uint8_t monthDays(uint8_t month);
+
+/// @brief function to find the weekday of a day of a month in the current year.
+uint8_t findWeekday(uint8_t month, uint8_t day);
+
+/// @brief function to find the day of the month a daylight saving rule falls on in the current year.
+uint8_t ruleDay(uint8_t rule);
+
+/// @brief function to set dst_on from the daylight saving rules that have passed this year, for when the date is set.
+void findSeason(void);
+
+/// @brief function to find today's daylight saving shift and store it in dstMinute, once a day and when the time or date is set.
+void findTransition(void);
+
+/// @brief function to move the time an hour on or back at the daylight saving shift.
+void shiftHour(void);
+
+/// @brief function to move the date on to the next day, at midnight.
+void nextDay(void);
+
+/// @brief function to step the date by a month and/or by a day, for setting the date.
+void editDate(uint8_t sw_edit);
+
+/// @brief function to step a time struct by an hour and/or by minutes, for setting time and alarm.
+void editTime(volatile struct time *p_time, uint8_t sw_edit, uint8_t minutes);
+
+/// @brief function to convert a time struct to minutes since midnight.
+uint16_t toMinutes(volatile struct time *p_time);
+
+/// @brief function to find the enabled alarm that comes up soonest after the current minute and store it in nextAlarm.
+void findNextAlarm(void);
+
+/// @brief function to restart the seconds when time set is let go, lined up on the 2 Hz edges so the first second is as close to a second as they allow.
+void alignSeconds(void);
+
+/// @brief function to step the time or alarm being set by the held hour and minute switches.
+void stepSwitches(uint8_t minutes);
+
+/// @brief function to apply one debounced switch state from the scan task, acts on the switches pressed since the last state.
+void switchEvent(uint8_t state);
+
+/// @brief function to step the time or alarm again when the autorepeat timer expires.
+void repeatSwitches(void);
+
+/// @brief function to turn the shown alarm slot on or off when the alarm on/off switch has been held long enough in alarm set.
+void holdAlarm(void);
+
+/// @brief function to keep the switch scan burst going, run from the scan task during a burst.
+void scanSwitches(void);
+
+/// @brief function to start the alarm sounding from the first step of its pattern.
+void startAlarm(void);
+
+/// @brief function to stop the alarm sounding.
+void stopAlarm(void);
+
+/// @brief function to play the next step of the alarm pattern and time its duration.
+void playTone(void);
+
+/// @brief function to start or restart a timer that expires after delay scans, delay must be at least 1.
+void startTimer(uint8_t timer, uint16_t delay);
+
+/// @brief function to stop a timer, clearing it from the wheel and any pending event.
+void stopTimer(uint8_t timer);
+
+/// @brief function to collect the timers that expired since the last call, timers with time left are sent round the wheel again.
+uint8_t pollTimers(void);
+
+/// @brief function to move the timer wheel on a slot, once per scan.
+void moveTimers(void);
+
+/// @brief task to advance the time by a minute and check the alarms, runs on minute_changed.
+void minuteTask(void);
+
+/// @brief task to check the seconds path in with the watchdog and refresh the stats, runs on second_changed.
+void secondTask(void);
+
+/// @brief task to start a switch scan burst, runs on input_ready.
+void inputTask(void);
+
+/// @brief task to move the timer wheel, handle expired timers and scan the switches, runs on scan_ready.
+void scanTask(void);
+
+/// @brief task to render the current time frame, runs on time_changed.
+void timeTask(void);
+
+/// @brief task to render the alarm frame and LEDs and find the next alarm, runs on alarm_changed.
+void alarmTask(void);
+
+/// @brief task to multiplex the display on to the next digit, runs on tick_ready.
+void displayTask(void);
+
+/// @def Struct to hold one scheduler task, the task runs when its event bit is set.
+struct task
+{
+  uint8_t event;
+  void (*run)(void);
+};
+
+/// @brief scheduler task table in priority order, the first task with its event set runs to completion before the table is checked again.
+const struct task taskArray[] = {
+  {EVENT_MINUTE, minuteTask},
+  {EVENT_SECOND, secondTask},
+  {EVENT_INPUT,  inputTask},
+  {EVENT_SCAN,   scanTask},
+  {EVENT_TIME,   timeTask},
+  {EVENT_ALARM,  alarmTask},
+  {EVENT_TICK,   displayTask}
+};
+
 /// @brief main entry point for program.
 int main(void)
 {
-  /// @brief local variable to store previous digitSelect value. Only set ports when it changes to keep application from resetting values needlessly.
-  uint8_t prev_digitSelect = 1;
-
+  /// @brief local variable for the events taken from taskEvents that have not had their task run yet.
+  uint8_t pending = 0;
+  /// @brief local variable for the task being checked, index into taskArray.
+  uint8_t task;
+  /// @brief local variable to tell if the time in ram was kept over the reset.
+  uint8_t warm = (warmMagic == WARM_MAGIC);
+
+  initState();
+
+  // render both frames on the first pass.
+  taskEvents = EVENT_TIME | EVENT_ALARM;
+
+#ifdef TARGET_AT89S52
+  // Setup 89s52 for timer 2 16 bit auto-reload, counter 1, and interrupt enable.
+  TMOD  = 0x50;
+  T2CON = 0x00;
+  RCAP2H = TH0_START;
+  RCAP2L = TL0_START;
+  TH2   = TH0_START;
+  TL2   = TL0_START;
+#else
   // Setup 89s51 for timer 0, counter 1, and interrupt enable.
   TMOD  = 0x51;
   TH0   = TH0_START;
   TL0   = TL0_START;
+#endif
   TH1   = TH1_START;
   TL1   = TL1_START;
   // enable interrupts
-  ET0   = 1;
+  TICK_ENABLE = 1;
   ET1   = 1;
+  // alarm on/off (INT0) and time set (INT1) switches interrupt on the falling edge to start a scan burst.
+  IT0   = 1;
+  IT1   = 1;
+  EX0   = 1;
+  EX1   = 1;
   EA    = 1;
+#ifdef TARGET_AT89S52
+  TR2   = 1;
+#else
   TR0   = 1;
+#endif
   TR1   = 1;
   // change priorities so timer 1 is highest.
   PS  = 0;
@@ -148,6 +663,9 @@ int main(void)
   PX1 = 0;
   PT0 = 0;
   PX0 = 0;
+#ifdef TARGET_AT89S52
+  PT2 = 0;
+#endif
   /// @brief P0 is 7 segment LED driver
   P0  = segmentArray[0];
   /// @brief P1 is the seconds binary leds, DOT LED, and alarm led outputs
@@ -157,316 +675,1269 @@ int main(void)
   /// @brief P3 is the switch input, and counter input for the seconds clock (2 Hz).
   P3  = 0x3F;
 
-  waitForTimeSet();
-
-  // loop forever
-  for(;;)
+  // a warm restart goes straight back to the kept time and alarms, otherwise the time has to be set.
+  if(warm)
   {
-    // if the previous digit select is not equal to the current digit select, update display.
-    if(prev_digitSelect != digitSelect)
+    // seconds is not in the checksum, it may have been mid update.
+    if(seconds > 59)
     {
-      // Turn off the LED's for a moment, this reduces flicker issues.
-      P0 = 0;
+      seconds = 0;
+    }
+
+    ALARM_LED = !alarm_on_off;
+
+    findTransition();
+  }
+  else
+  {
+    // the C startup has cleared the time and alarms, only slot 0 starts enabled. The date starts at Saturday 1 January 2000.
+    alarmEnable = 0x01;
+
+    gs_date.day     = 1;
+    gs_date.month   = 1;
+    gs_date.year    = 0;
+    gs_date.weekday = findWeekday(gs_date.month, gs_date.day);
+
+    findSeason();
+    waitForTimeSet();
+
+    warmMagic = WARM_MAGIC;
+  }
+
+  keepState();
 
-      // seconds, complimented since 0 is 1 or on.
-      P1 = (P1 & 0xC0) | (!SET_A_SWITCH ? 0x00 : (~seconds & 0x3F));
+  // start the watchdog, from here it has to be fed every 16 ms. Only a reset stops it.
+  WDT_RST = 0x1E;
+  WDT_RST = 0xE1;
 
-      // update previous digit select
-      prev_digitSelect = digitSelect;
+  // loop forever, a run to completion scheduler. Each pass runs the highest priority task with its event set.
+  for(;;)
+  {
+    // take the new events in one go, interrupts are off for only the copy and clear.
+    EA = 0;
+    pending |= taskEvents;
+    taskEvents = 0;
+    EA = 1;
 
-      // assert digit select and set alarm tone every other seconds.
-      P2 = (alarm_tone << 4) | (digitSelect & 0x0F);
+    for(task = 0; task < TASK_COUNT; task++)
+    {
+      if(pending & taskArray[task].event)
+      {
+        break;
+      }
+    }
 
-      // turn the DOT LED on when seconds is 1, off when 0.
-      DOT_LED = ((!SET_T_SWITCH || !SET_A_SWITCH) ? 0 : seconds & 0x01);
+    if(task < TASK_COUNT)
+    {
+      pending &= ~taskArray[task].event;
+      taskArray[task].run();
+    }
+    else
+    {
+      // nothing to run, idle the cpu till the next interrupt, the millisecond tick wakes it at the latest. taskEvents is checked with
+      // interrupts off and idle set right after EA, the 8051 runs the instruction after a write to IE before taking an interrupt.
+      // An event set after the copy above is not left waiting a tick, its interrupt is taken first or ends the idle.
+      EA = 0;
 
-      // based on selected digit, send out the digit to the proper 7 segment led. if alarm switch is held, show the alarm set time.
-      switch(digitSelect)
+      if(!taskEvents)
       {
-        case SEG_ONE_MINUTE:
-          P0 = segmentArray[(SET_A_SWITCH ? gs_timeKeeper.one_minutes : gs_alarmKeeper.one_minutes)];
-          break;
-        case SEG_TEN_MINUTE:
-          P0 = segmentArray[(SET_A_SWITCH ? gs_timeKeeper.ten_minutes : gs_alarmKeeper.ten_minutes)];
-          break;
-        case SEG_ONE_HOUR:
-          P0 = segmentArray[(SET_A_SWITCH ? gs_timeKeeper.one_hours : gs_alarmKeeper.one_hours)];
-          break;
-        case SEG_TEN_HOUR:
-          P0 = segmentArray[(SET_A_SWITCH ? gs_timeKeeper.ten_hours : gs_alarmKeeper.ten_hours)];
-          break;
+        EA = 1;
+        PCON |= IDL;
       }
+
+      EA = 1;
     }
   }
 
   return 0;
 }
 
-// function to flash clock at 00:00 on/off per second till time set pressed. Indicates power outage and the clock needs to be set.
-inline void waitForTimeSet()
+// function called by the C startup before ram is cleared, a non zero return skips the clear and all initializers.
+unsigned char _sdcc_external_startup(void)
 {
-  // wait for a second till 2 Hz clock stabilizes.
-  while(milliseconds < 1000);
+  // a watchdog or soft reset leaves ram alone, keep it if the time was running and the kept state checks out.
+  return ((warmMagic == WARM_MAGIC) && (warmCheck == warmChecksum()));
+}
 
-  // reset 2 Hz clock
-  TH1     = TH1_START;
-  TL1     = TL1_START;
-  seconds = 0;
+// function to checksum the state kept over a warm restart, everything but seconds which changes in the timer isr.
+uint8_t warmChecksum(void)
+{
+  /// @brief local variable for the alarm slot being added.
+  uint8_t index;
+  /// @brief local variable for the running sum of the kept bytes.
+  uint8_t sum = (uint8_t)minuteOfDay + (uint8_t)(minuteOfDay >> 8) + alarmEnable + (alarm_on_off ? 1 : 0) + (dst_on ? 2 : 0) + (date_set ? 4 : 0);
+
+  sum += gs_timeKeeper.one_minutes + gs_timeKeeper.ten_minutes + gs_timeKeeper.one_hours + gs_timeKeeper.ten_hours;
+  sum += gs_date.day + gs_date.month + gs_date.year + gs_date.weekday;
 
-  // wait till set switch is pressed
-  while(SET_T_SWITCH)
+  for(index = 0; index < ALARM_SLOTS; index++)
   {
-    // flash all digits at once with 0
-    P2      = ((seconds & 0x01) ? 0x0F : 0x00);
-    // flash dot LED's in sync
-    DOT_LED = seconds & 0x01;
-    // roll seconds from 0,1,0,1... so that the clock doesn't start incrementing time.
-    seconds = seconds & 0x01;
+    sum += gs_alarmKeeper[index].one_minutes + gs_alarmKeeper[index].ten_minutes + gs_alarmKeeper[index].one_hours + gs_alarmKeeper[index].ten_hours;
   }
 
-  // reset seconds when time is set to 0 just cause, not really needed.
-  seconds = 0;
+  // complimented so all zero ram does not check out.
+  return ~sum;
 }
 
-/// @brief control_isr is a interrupt function for timer 0 when a over flow occurs. This also processed button presses.
-void control_isr (void) __interrupt (TF0_VECTOR)
+// function to update warmCheck after the kept state changes.
+void keepState(void)
 {
-  // reset timer overflow, though it does this anyways.
-  TF0 = 0;
-
-  // reset timer counters start point.
-  TH0 = TH0_START;
-  TL0 = TL0_START;
-
-  // its been a millisecond, increment
-  milliseconds++;
+  warmCheck = warmChecksum();
+}
 
-  // check if the alarm on/off switch is being pressed.
-  if(!ALARM_SWITCH)
+// function to set all runtime state, the initializers are skipped on a warm restart so nothing relies on them.
+void initState(void)
+{
+  /// @brief local variable for the array entry being cleared.
+  uint8_t index;
+
+  digitSelect   = 0;
+  sw_count0     = 0xFF;
+  sw_count1     = 0xFF;
+  sw_state      = 0;
+  sw_held       = 0;
+  repeatStage   = 0;
+  repeatCount   = 0;
+  scanTimeout   = 0;
+  scanBurst     = SCAN_BURST;
+  timerPos      = 0;
+  timerEvents   = 0;
+
+  for(index = 0; index < TIMER_SLOTS; index++)
   {
-    // if the switch is below the the min delay, increment it till it is greater
-    switchTimeout = (switchTimeout > MIN_DELAY ? switchTimeout : switchTimeout + 1);
+    timerWheel[index] = 0;
+  }
 
-    // once the switch timeout is equal to the min delay, allow a button press.
-    if(switchTimeout == MIN_DELAY)
-    {
-      // toggle the alarm on or off
-      alarm_on_off = ((alarm_on_off == ON) ? OFF : ON);
+  for(index = 0; index < TIMER_COUNT; index++)
+  {
+    timerRemain[index] = 0;
+  }
 
-      ALARM_LED = !alarm_on_off;
+  toneStep      = 0;
+  edgeCount     = TL1;
+  edgeAge       = 0;
+  secondTimeout = SECOND_DEADLINE;
+  display_alive = OFF;
+  nextAlarm     = NO_ALARM;
+  snoozeAlarm   = NO_ALARM;
+  alarmSlot     = 0;
+  alarmHold     = OFF;
+  alarmLeds     = 0x3F;
+  maxLatency    = 0;
+  overrunCount  = 0;
+  preemptCount  = 0;
+  statsPage     = 0;
+  timeShow      = SHOW_TIME;
+  control_busy  = OFF;
+  date_edit     = OFF;
+  alarm_sounding = OFF;
+  alarm_tone    = 0;
+}
 
-      // make sure to turn off the tone if the alarm is turned off.
-      if(alarm_on_off == OFF)
-      {
-        prev_milliseconds = 0;
-        alarm_tone = 0;
-      }
-    }
+// function to feed the watchdog if the tick, the seconds path and the display have all checked in.
+void feedWatchdog(void)
+{
+  // the seconds path has until the deadline to check in again.
+  if(secondTimeout != 0)
+  {
+    secondTimeout--;
   }
-  // check if the alarm set switch is being pressed.
-  else if(!SET_A_SWITCH)
+
+  // this runs from the scan task, so the tick is alive. Feed only if the display ran and the seconds path is in time.
+  if((display_alive == ON) && (secondTimeout != 0))
   {
-    // increment switch timeout
-    switchTimeout++;
+    display_alive = OFF;
 
-    // when both switches are not pressed, reset initial delay.
-    if(MINUTE_SWITCH && HOUR_SWITCH)
-    {
-      initTimeout = INIT_DELAY;
-    }
+    WDT_RST = 0x1E;
+    WDT_RST = 0xE1;
+  }
+  // a stopped seconds path leaves the time wrong, so the restart is cold and flashes 00:00 for a time set.
+  else if(secondTimeout == 0)
+  {
+    warmMagic = 0;
+  }
+}
 
-    // when either switch is pressed, and the press as exceeded the current timeout allow a button press
-    if((!MINUTE_SWITCH || !HOUR_SWITCH) && (switchTimeout > initTimeout))
+// function to flash clock at 00:00 on/off per second till time set pressed. Indicates power outage and the clock needs to be set.
+inline void waitForTimeSet()
+{
+  /// @brief local variable for the power up state, START_SETTLE or START_FLASH.
+  uint8_t  state   = START_SETTLE;
+  /// @brief local variable for the milliseconds since the last 2 Hz falling edge.
+  uint16_t spacing = 0;
+  /// @brief local variable for the in range edge spacings in a row.
+  uint8_t  edges   = 0;
+  /// @brief local variable for the last timer 1 count, it moves on each 2 Hz falling edge.
+  uint8_t  count   = TL1;
+  /// @brief local variable for the milliseconds into the flash while settling.
+  uint16_t flash   = 0;
+  /// @brief local variable for the milliseconds spent settling, START_FLASH follows at SETTLE_TIME.
+  uint16_t settle  = 0;
+
+  // flash 00:00 straight away, wait till the 2 Hz clock is stable and then till the set switch is pressed.
+  while((state == START_SETTLE) || SET_T_SWITCH)
+  {
+    if(state == START_SETTLE)
     {
-      // when minute is pressed add one
-      gs_alarmKeeper.one_minutes += (MINUTE_SWITCH ? 0 : 1);
-
-      // when hour is pressed add one
-      gs_alarmKeeper.one_hours += (HOUR_SWITCH ? 0 : 1);
-
-      // the below is the same code used in timer ISR. copy pasta with tweaks
-      if(gs_alarmKeeper.one_minutes > 9)
+      // time the 2 Hz edges with the millisecond tick, timer 1 counts the edges.
+      if(tick_ready == ON)
       {
-        gs_alarmKeeper.ten_minutes++;
-        gs_alarmKeeper.one_minutes = 0;
+        tick_ready = OFF;
+
+        spacing++;
+        settle++;
+        flash = ((flash >= (FLASH_TIME - 1)) ? 0 : flash + 1);
+
+        if(TL1 != count)
+        {
+          count   = TL1;
+          edges   = (((spacing >= EDGE_MIN) && (spacing <= EDGE_MAX)) ? edges + 1 : 0);
+          spacing = 0;
+        }
       }
 
-      if(gs_alarmKeeper.ten_minutes > 5)
+      // once stable, or at SETTLE_TIME so a bad 2 Hz clock does not keep time set out forever.
+      if((edges >= START_EDGES) || (settle >= SETTLE_TIME))
       {
-        gs_alarmKeeper.ten_minutes = 0;
+        // reset 2 Hz clock, the seconds start from here.
+        TH1     = TH1_START;
+        TL1     = TL1_START;
+        seconds = 0;
+        state   = START_FLASH;
       }
 
-      if(gs_alarmKeeper.one_hours > 9)
-      {
-        gs_alarmKeeper.ten_hours++;
-        gs_alarmKeeper.one_hours = 0;
-      }
+      // flash all digits at once with 0, and the dot LED's in sync.
+      P2      = ((flash < (FLASH_TIME / 2)) ? 0x0F : 0x00);
+      DOT_LED = (flash < (FLASH_TIME / 2));
+    }
+    else
+    {
+      // flash all digits at once with 0
+      P2      = ((seconds & 0x01) ? 0x0F : 0x00);
+      // flash dot LED's in sync
+      DOT_LED = seconds & 0x01;
+    }
 
-      if((gs_alarmKeeper.ten_hours >= 2) && (gs_alarmKeeper.one_hours >= 4))
-      {
-        gs_alarmKeeper.ten_hours = 0;
-        gs_alarmKeeper.one_hours = 0;
-      }
+    // roll seconds from 0,1,0,1... so that the clock doesn't start incrementing time.
+    seconds = seconds & 0x01;
+
+    // idle till the next interrupt, the millisecond tick wakes it at the latest.
+    PCON |= IDL;
+  }
+
+  // reset seconds when time is set to 0 just cause, not really needed.
+  seconds = 0;
+}
+
+// function to convert a time struct to minutes since midnight.
+uint16_t toMinutes(volatile struct time *p_time)
+{
+  return (uint16_t)p_time->ten_hours * 600 + p_time->one_hours * 60 + p_time->ten_minutes * 10 + p_time->one_minutes;
+}
+
+// function to find the enabled alarm that comes up soonest after the current minute and store it in nextAlarm.
+void findNextAlarm(void)
+{
+  /// @brief local variable for the alarm slot being checked.
+  uint8_t  index;
+  /// @brief local variable for the alarm slot time in minutes since midnight.
+  uint16_t minutes;
+  /// @brief local variable for the minutes from now till the alarm slot, 1 to a full day.
+  uint16_t delta;
+  /// @brief local variable for the smallest delta found so far.
+  uint16_t best_delta = NO_ALARM;
+
+  nextAlarm = NO_ALARM;
+
+  for(index = 0; index < ALARM_SLOTS; index++)
+  {
+    if(alarmEnable & bitArray[index])
+    {
+      minutes = toMinutes(&gs_alarmKeeper[index]);
 
-      // clear switch timeout since press has happened
-      switchTimeout = 0;
+      // an alarm at or before the current minute is next due tomorrow.
+      delta = ((minutes > minuteOfDay) ? minutes - minuteOfDay : minutes + MINUTES_PER_DAY - minuteOfDay);
 
-      // if the initial timeout is greater then the minimal delay, ramp it down so holding the button will get faster.
-      if(initTimeout > MIN_DELAY)
+      if(delta < best_delta)
       {
-        initTimeout = initTimeout - RAMP_DELAY;
+        best_delta = delta;
+        nextAlarm  = minutes;
       }
     }
   }
-  // check if the time set switch is being pressed.
-  else if(!SET_T_SWITCH)
-  {
-    // increment switch timeout
-    switchTimeout++;
+}
 
-    // when both switches are not pressed, reset initial delay.
-    if(MINUTE_SWITCH && HOUR_SWITCH)
-    {
-      initTimeout = INIT_DELAY;
-    }
+// function to restart the seconds when time set is let go, lined up on the 2 Hz edges so the first second is as close to a second as they allow.
+void alignSeconds(void)
+{
+  // the 2 Hz divider can not be reset, so the first second ends on an edge. Let go early in a half second the 2nd edge from here is nearest a second away, late the 3rd.
+  ET1 = 0;
 
-    // when either switch is pressed, and the press as exceeded the current timeout allow a button press
-    if((!MINUTE_SWITCH || !HOUR_SWITCH) && (switchTimeout > initTimeout))
-    {
-      // when minute is pressed add one
-      gs_timeKeeper.one_minutes += (MINUTE_SWITCH ? 0 : 1);
+  TH1 = TH1_START;
+  TL1 = ((edgeAge < EDGE_HALF) ? TL1_START : TL1_LATE);
+  TF1 = 0;
 
-      // when hour is pressed add one
-      gs_timeKeeper.one_hours += (HOUR_SWITCH ? 0 : 1);
+  // the timer isr may have counted a second between the switch letting go and the debounced release.
+  seconds = 0;
 
-      // the below is the same code used in timer ISR. copy pasta with tweaks
-      if(gs_timeKeeper.one_minutes > 9)
-      {
-        gs_timeKeeper.ten_minutes++;
-        gs_timeKeeper.one_minutes = 0;
-      }
+  ET1 = 1;
 
-      if(gs_timeKeeper.ten_minutes > 5)
-      {
-        gs_timeKeeper.ten_minutes = 0;
-      }
+  edgeCount = TL1;
 
-      if(gs_timeKeeper.one_hours > 9)
-      {
-        gs_timeKeeper.ten_hours++;
-        gs_timeKeeper.one_hours = 0;
-      }
+  // the next second is counted from here, give it the full deadline.
+  secondTimeout = SECOND_DEADLINE;
+}
 
-      if((gs_timeKeeper.ten_hours >= 2) && (gs_timeKeeper.one_hours >= 4))
-      {
-        gs_timeKeeper.ten_hours = 0;
-        gs_timeKeeper.one_hours = 0;
-      }
+// function to step the time or alarm being set by the held hour and minute switches.
+void stepSwitches(uint8_t minutes)
+{
+  // both set switches held together set the date, till both are released.
+  if(date_edit == ON)
+  {
+    editDate(sw_held);
 
-      // clear switch timeout since press has happened
-      switchTimeout = 0;
+    // tell main the date needs to be rendered.
+    time_changed = ON;
+  }
+  // check if the alarm set switch is being held, it has priority over time set.
+  else if(sw_held & SW_SET_A)
+  {
+    editTime(&gs_alarmKeeper[alarmSlot], sw_held, minutes);
 
-      // if the initial timeout is greater then the minimal delay, ramp it down so holding the button will get faster.
-      if(initTimeout > MIN_DELAY)
-      {
-        initTimeout = initTimeout - RAMP_DELAY;
-      }
-    }
+    // tell main the alarm frame needs to be rendered.
+    alarm_changed = ON;
   }
-  // if no switch is pressed, timeout is cleared and initial timeout is set to initial value.
+  // otherwise the time set switch is being held.
   else
   {
-    switchTimeout = 0;
-    initTimeout   = INIT_DELAY;
-  }
+    editTime(&gs_timeKeeper, sw_held, minutes);
 
-  // when alarm tone is not 0, the alarm is on, decrement alarm tone to change the current tone played.
-  if(alarm_tone != 0)
-  {
-    if((milliseconds - prev_milliseconds) > TONE_TIME)
-    {
-      prev_milliseconds = milliseconds;
-      alarm_tone = ((alarm_tone <= 1) ? 7 : alarm_tone - 1);
-    }
-  }
+    // keep the minute of the day with the time, the next alarm depends on it.
+    minuteOfDay = toMinutes(&gs_timeKeeper);
+    findNextAlarm();
 
-  // move digit selection by one on each millisecond.
-  digitSelect = (digitSelect < (1 << 3) ? digitSelect << 1 : 1);
+    // the new time may be either side of today's rule.
+    findSeason();
+    findTransition();
 
+    // tell main the time frame needs to be rendered.
+    time_changed = ON;
+  }
 }
 
-/// @brief Keep track of time in seconds as precisely as possible.
-void timer_isr (void) __interrupt (TF1_VECTOR)
+// function to apply one debounced switch state from the scan task, acts on the switches pressed since the last state.
+void switchEvent(uint8_t state)
 {
-  // reset timer overflow, though it does this anyways.
-  TF1 = 0;
+  /// @brief local variable for switches that were pressed since the last state.
+  uint8_t sw_press = state & ~sw_held;
+  /// @brief local variable for switches that were released since the last state.
+  uint8_t sw_release = sw_held & ~state;
+  /// @brief local variable for what the time frame shows with this switch state.
+  uint8_t show;
 
-  // reset timer counters start point.
-  TH1 = TH1_START;
-  TL1 = TL1_START;
+  sw_held = state;
 
-  // check if the time set switch is pressed. If so keep seconds at and hold.
-  if(!SET_T_SWITCH)
+  if((sw_held & SW_SET_DATE) == SW_SET_DATE)
   {
-    seconds = 0;
-    return;
+    date_edit = ON;
   }
 
-  // increment seconds on each timer overflow.
-  seconds++;
+  // the seconds start again from the time set release, but not from leaving date set where they kept going.
+  if((sw_release & SW_SET_T) && (date_edit == OFF))
+  {
+    alignSeconds();
+  }
 
-  // once over 59 seconds, increment minutes and reset seconds
-  if(seconds > 59)
+  // date set ends once both set switches are up, so one left held does not turn into time or alarm set.
+  if(!(sw_held & SW_SET_DATE))
   {
-    gs_timeKeeper.one_minutes++;
-    seconds = 0;
+    date_edit = OFF;
   }
 
-  // once over 9 minutes, increment ten minutes and reset minutes
-  if(gs_timeKeeper.one_minutes > 9)
+  // the time frame shows the date while it is set or minute is held on its own, and the year while hour is held on its own.
+  show = SHOW_TIME;
+
+  if(date_edit == ON)
   {
-    gs_timeKeeper.ten_minutes++;
-    gs_timeKeeper.one_minutes = 0;
+    show = SHOW_DATE;
   }
+  // hidden, hour and minute held together outside of time and alarm set show the isr timing stats in place of the time. Each new press shows the next page.
+  else if((sw_held & (SW_STATS | SW_SET_A | SW_SET_T)) == SW_STATS)
+  {
+    show = SHOW_STATS;
 
-  // once over 5 ten minutes, increment hours and reset ten minutes.
-  if(gs_timeKeeper.ten_minutes > 5)
+    if((sw_press & SW_STATS) && (alarm_sounding == OFF))
+    {
+      statsPage    = ((statsPage >= STATS_PAGES) ? 1 : statsPage + 1);
+      time_changed = ON;
+    }
+  }
+  else if((sw_held & SW_MASK) == SW_DATE)
+  {
+    show = SHOW_DATE;
+  }
+  else if((sw_held & SW_MASK) == SW_YEAR)
   {
-    gs_timeKeeper.one_hours++;
-    gs_timeKeeper.ten_minutes = 0;
+    show = SHOW_YEAR;
   }
 
-  // once over 9 one hours, increment ten hours and reset one hours.
-  if(gs_timeKeeper.one_hours > 9)
+  if(show != timeShow)
   {
-    gs_timeKeeper.ten_hours++;
-    gs_timeKeeper.one_hours = 0;
+    timeShow     = show;
+    time_changed = ON;
   }
 
-  // once ten hours is at or above 2, and one hours is at or above 4, reset both to 0.
-  if((gs_timeKeeper.ten_hours >= 2) && (gs_timeKeeper.one_hours >= 4))
+  // while the alarm is sounding, a switch press snoozes it instead of doing its usual job.
+  if((alarm_sounding == ON) && (sw_press & SW_SNOOZE))
   {
-    gs_timeKeeper.ten_hours = 0;
-    gs_timeKeeper.one_hours = 0;
+    stopAlarm();
+
+    snoozeAlarm = minuteOfDay + SNOOZE_MINUTES;
+
+    if(snoozeAlarm >= MINUTES_PER_DAY)
+    {
+      snoozeAlarm = snoozeAlarm - MINUTES_PER_DAY;
+    }
+
+    return;
   }
 
-  // if alarm is on, compare the elements to see if we have hit the correct time.
-  if(alarm_on_off == ON)
+  // in alarm set, a short press of the alarm on/off switch shows the next alarm slot. A long hold is handled in holdAlarm.
+  if(sw_held & SW_SET_A)
   {
-    if((gs_alarmKeeper.ten_hours == gs_timeKeeper.ten_hours) && (gs_alarmKeeper.one_hours == gs_timeKeeper.one_hours) && (gs_alarmKeeper.ten_minutes == gs_timeKeeper.ten_minutes) && (gs_alarmKeeper.one_minutes == gs_timeKeeper.one_minutes))
+    if(sw_press & SW_ALARM)
     {
+      alarmHold = ON;
+      startTimer(TIMER_HOLD, ALARM_HOLD);
+    }
 
-      if(seconds == 0)
-      {
-        prev_milliseconds = milliseconds;
-        alarm_tone = 7;
-      }
+    if((sw_release & SW_ALARM) && (alarmHold == ON))
+    {
+      alarmHold = OFF;
+      stopTimer(TIMER_HOLD);
 
-      if(seconds >= 59)
-      {
-        prev_milliseconds = 0;
-        alarm_tone = 0;
-      }
+      alarmSlot = (alarmSlot + 1) & (ALARM_SLOTS - 1);
+      alarm_changed = ON;
+    }
+  }
+  // otherwise toggle the alarm on or off when the alarm on/off switch is pressed.
+  else if(sw_press & SW_ALARM)
+  {
+    // a press that started outside alarm set is never a slot change.
+    alarmHold = OFF;
+
+    alarm_on_off = ((alarm_on_off == ON) ? OFF : ON);
+
+    ALARM_LED = !alarm_on_off;
+
+    // the alarm on/off is kept over a warm restart, the alarm task updates the checksum.
+    alarm_changed = ON;
+
+    // make sure to turn off the tone and any snooze if the alarm is turned off.
+    if(alarm_on_off == OFF)
+    {
+      stopAlarm();
+      snoozeAlarm = NO_ALARM;
+    }
+  }
+
+  // step once on an hour or minute press while alarm set or time set is held, and restart the acceleration.
+  if((sw_press & (SW_HOUR | SW_MINUTE)) && (sw_held & (SW_SET_A | SW_SET_T)))
+  {
+    repeatStage   = 0;
+    repeatCount   = 0;
+
+    stepSwitches(1);
+
+    startTimer(TIMER_REPEAT, repeatArray[repeatStage].delay);
+  }
+}
+
+// function to step the time or alarm again when the autorepeat timer expires.
+void repeatSwitches(void)
+{
+  // hour and minute only change something while alarm set or time set is still held, otherwise the autorepeat ends here.
+  if((sw_held & (SW_SET_A | SW_SET_T)) && (sw_held & (SW_HOUR | SW_MINUTE)))
+  {
+    stepSwitches(repeatArray[repeatStage].minutes);
+
+    // move to the next stage once this one has used up its steps, the last stage has a count of 0 and repeats forever.
+    if(repeatArray[repeatStage].count && (++repeatCount >= repeatArray[repeatStage].count))
+    {
+      repeatStage++;
+      repeatCount = 0;
     }
+
+    startTimer(TIMER_REPEAT, repeatArray[repeatStage].delay);
+  }
+}
+
+// function to turn the shown alarm slot on or off when the alarm on/off switch has been held long enough in alarm set.
+void holdAlarm(void)
+{
+  if((alarmHold == ON) && ((sw_held & (SW_SET_A | SW_ALARM)) == (SW_SET_A | SW_ALARM)))
+  {
+    alarmEnable = alarmEnable ^ bitArray[alarmSlot];
+    alarm_changed = ON;
+  }
+
+  // the release that follows is not a short press.
+  alarmHold = OFF;
+}
+
+// function to keep the switch scan burst going, run from the scan task during a burst.
+void scanSwitches(void)
+{
+  // keep scanning while a switch is down or the alarm is sounding, otherwise count the burst down to 0.
+  if(sw_held || (~P3 & SW_MASK) || alarm_sounding)
+  {
+    scanBurst = SCAN_BURST;
   }
+  else if(scanBurst != 0)
+  {
+    scanBurst--;
+  }
+}
+
+// function to start the alarm sounding from the first step of its pattern.
+void startAlarm(void)
+{
+  alarm_sounding = ON;
+  scanBurst      = SCAN_BURST;
+  toneStep       = patternArray[ALARM_PATTERN];
+
+  startTimer(TIMER_ALARM, ALARM_TIME);
+  playTone();
+}
+
+// function to stop the alarm sounding.
+void stopAlarm(void)
+{
+  alarm_sounding = OFF;
+  alarm_tone     = 0;
+
+  stopTimer(TIMER_TONE);
+  stopTimer(TIMER_ALARM);
+}
+
+// function to play the next step of the alarm pattern and time its duration.
+void playTone(void)
+{
+  // a duration of 0 ends the pattern, go back to its first step.
+  if(toneArray[toneStep].duration == 0)
+  {
+    toneStep = patternArray[ALARM_PATTERN];
+  }
+
+  alarm_tone = toneArray[toneStep].channel;
+
+  startTimer(TIMER_TONE, toneArray[toneStep].duration);
+
+  toneStep++;
+}
+
+// function to start or restart a timer that expires after delay scans, delay must be at least 1.
+void startTimer(uint8_t timer, uint16_t delay)
+{
+  /// @brief local variable for the scans till this trip round the wheel ends, at most a full turn.
+  uint8_t ticks = ((delay < TIMER_SLOTS) ? delay : TIMER_SLOTS);
+
+  stopTimer(timer);
+
+  timerRemain[timer] = delay - ticks;
+
+  timerWheel[(timerPos + ticks) & TIMER_MASK] |= bitArray[timer];
+}
+
+// function to stop a timer, clearing it from the wheel and any pending event.
+void stopTimer(uint8_t timer)
+{
+  /// @brief local variable for the timer wheel slot being cleared.
+  uint8_t index;
+
+  for(index = 0; index < TIMER_SLOTS; index++)
+  {
+    timerWheel[index] &= ~bitArray[timer];
+  }
+
+  timerEvents &= ~bitArray[timer];
+  timerRemain[timer] = 0;
+}
+
+// function to collect the timers that expired since the last call, timers with time left are sent round the wheel again.
+uint8_t pollTimers(void)
+{
+  /// @brief local variable for the timers that expired.
+  uint8_t events;
+  /// @brief local variable for the timer being checked.
+  uint8_t timer;
+
+  events = timerEvents;
+  timerEvents = 0;
+
+  if(events)
+  {
+    for(timer = 0; timer < TIMER_COUNT; timer++)
+    {
+      if((events & bitArray[timer]) && timerRemain[timer])
+      {
+        events &= ~bitArray[timer];
+        startTimer(timer, timerRemain[timer]);
+      }
+    }
+  }
+
+  return events;
+}
+
+// function to move the timer wheel on a slot and collect the timers that expire on it, the same work however many are running.
+void moveTimers(void)
+{
+  timerPos = (timerPos + 1) & TIMER_MASK;
+  timerEvents |= timerWheel[timerPos];
+  timerWheel[timerPos] = 0;
+}
+
+// task to advance the time by a minute and check the alarms, runs on minute_changed.
+void minuteTask(void)
+{
+  gs_timeKeeper.one_minutes++;
+  minuteOfDay++;
+
+  // once over 9 minutes, increment ten minutes and reset minutes
+  if(gs_timeKeeper.one_minutes > 9)
+  {
+    gs_timeKeeper.ten_minutes++;
+    gs_timeKeeper.one_minutes = 0;
+
+    // once over 5 ten minutes, increment hours and reset ten minutes.
+    if(gs_timeKeeper.ten_minutes > 5)
+    {
+      gs_timeKeeper.one_hours++;
+      gs_timeKeeper.ten_minutes = 0;
+
+      // once over 9 one hours, increment ten hours and reset one hours.
+      if(gs_timeKeeper.one_hours > 9)
+      {
+        gs_timeKeeper.ten_hours++;
+        gs_timeKeeper.one_hours = 0;
+      }
+
+      // once ten hours is at or above 2, and one hours is at or above 4, reset both to 0.
+      if((gs_timeKeeper.ten_hours >= 2) && (gs_timeKeeper.one_hours >= 4))
+      {
+        gs_timeKeeper.ten_hours = 0;
+        gs_timeKeeper.one_hours = 0;
+        minuteOfDay = 0;
+
+        nextDay();
+      }
+    }
+  }
+
+  time_changed = ON;
+
+  // the daylight saving shift, only ever a single compare here.
+  if(minuteOfDay == dstMinute)
+  {
+    shiftHour();
+  }
+
+  // a snoozed alarm sounds again when its minute comes up.
+  if(minuteOfDay == snoozeAlarm)
+  {
+    snoozeAlarm = NO_ALARM;
+    startAlarm();
+  }
+
+  if(minuteOfDay == nextAlarm)
+  {
+    // only sound it if the alarm is on.
+    if(alarm_on_off == ON)
+    {
+      startAlarm();
+    }
+
+    // find the alarm after this one, even when off so later alarms are not skipped.
+    alarm_changed = ON;
+  }
+}
+
+// task to check the seconds path in with the watchdog and refresh the stats, runs on second_changed.
+void secondTask(void)
+{
+  // the seconds path has checked in.
+  secondTimeout = SECOND_DEADLINE;
+
+  // refresh the isr timing stats while they are shown.
+  if(timeShow == SHOW_STATS)
+  {
+    time_changed = ON;
+  }
+}
+
+// task to start a switch scan burst, runs on input_ready.
+void inputTask(void)
+{
+  scanBurst = SCAN_BURST;
+}
+
+// task to move the timer wheel, handle expired timers and scan the switches, runs on scan_ready.
+void scanTask(void)
+{
+  /// @brief local variable for the timers that expired on this scan.
+  uint8_t expired;
+  /// @brief local variable for switches whose debounced state changed this scan.
+  uint8_t sw_change;
+
+  feedWatchdog();
+
+  // keep the phase of the 2 Hz clock for the time set release.
+  if(TL1 != edgeCount)
+  {
+    edgeCount = TL1;
+    edgeAge   = 0;
+  }
+  else if(edgeAge != 0xFF)
+  {
+    edgeAge++;
+  }
+
+  moveTimers();
+
+  expired = pollTimers();
+
+  if(expired & bitArray[TIMER_TONE])
+  {
+    playTone();
+  }
+
+  if(expired & bitArray[TIMER_REPEAT])
+  {
+    repeatSwitches();
+  }
+
+  if(expired & bitArray[TIMER_HOLD])
+  {
+    holdAlarm();
+  }
+
+  if(expired & bitArray[TIMER_ALARM])
+  {
+    stopAlarm();
+  }
+
+  // alarm set, hour and minute have no external interrupt, so a held switch starts a burst from here. This is how the stats and date views open on an idle clock.
+  if((scanBurst == 0) && ((P3 & SW_MASK) != SW_MASK))
+  {
+    scanBurst = SCAN_BURST;
+  }
+
+  // the switches are only scanned during a burst.
+  if(scanBurst != 0)
+  {
+    // debounce all switches in parallel, pressed switches read as 1. A switch must read the same for 4 scans to change state.
+    sw_change = sw_state ^ (~P3 & SW_MASK);
+    sw_count0 = ~(sw_count0 & sw_change);
+    sw_count1 = sw_count0 ^ (sw_count1 & sw_change);
+    sw_change = sw_change & sw_count0 & sw_count1;
+
+    // apply each new debounced state as it happens, so no press is lost.
+    if(sw_change)
+    {
+      sw_state = sw_state ^ sw_change;
+      switchEvent(sw_state);
+    }
+
+    scanSwitches();
+  }
+}
+
+// task to render the current time frame, runs on time_changed.
+void timeTask(void)
+{
+  if(timeShow == SHOW_STATS)
+  {
+    renderStats(timeFrame);
+  }
+  else if(timeShow == SHOW_TIME)
+  {
+    renderFrame(timeFrame, &gs_timeKeeper);
+  }
+  else
+  {
+    renderDate(timeFrame);
+  }
+
+  keepState();
+}
+
+// task to render the alarm frame and LEDs and find the next alarm, runs on alarm_changed.
+void alarmTask(void)
+{
+  renderFrame(alarmFrame, &gs_alarmKeeper[alarmSlot]);
+  alarmLeds = ~(((alarmEnable & bitArray[alarmSlot]) ? 0x20 : 0x00) | bitArray[alarmSlot]) & 0x3F;
+
+  findNextAlarm();
+
+  keepState();
+}
+
+// task to multiplex the display on to the next digit, runs on tick_ready.
+void displayTask(void)
+{
+  /// @brief local variable pointing at the frame to display, time or alarm. Both frames are in idata so the pointer is a single byte.
+  __idata uint8_t *p_frame;
+
+  PROFILE_ON(PROFILE_DISPLAY);
+
+  // move digit selection by one on each millisecond.
+  digitSelect = (digitSelect + 1) & 0x03;
+
+  // Turn off the LED's for a moment, this reduces flicker issues.
+  P0 = 0;
+
+  // seconds, the weekday (1 is Monday) with the date, or the alarm slot LEDs in alarm set. Complimented since 0 is on.
+  P1 = (P1 & 0xC0) | ((timeShow == SHOW_DATE) ? (~(gs_date.weekday + 1) & 0x3F) : ((!SET_A_SWITCH && SET_T_SWITCH) ? alarmLeds : (~seconds & 0x3F)));
+
+  // assert digit select and set alarm tone every other seconds.
+  P2 = (alarm_tone << 4) | digitArray[digitSelect];
+
+  // turn the DOT LED on when seconds is 1, off when 0.
+  DOT_LED = ((!SET_T_SWITCH || !SET_A_SWITCH) ? 0 : seconds & 0x01);
+
+  // if alarm switch is held on its own, show the alarm set time frame, otherwise the current time frame. Both set switches together set the date in the time frame.
+  p_frame = ((!SET_A_SWITCH && SET_T_SWITCH && !date_edit) ? alarmFrame : timeFrame);
+
+  // send out the selected digit from the frame to the proper 7 segment led.
+  P0 = p_frame[digitSelect];
+
+  // the display has checked in.
+  display_alive = ON;
+
+  PROFILE_OFF(PROFILE_DISPLAY);
+}
+
+// function to step a time struct by an hour and/or by minutes, for setting time and alarm.
+void editTime(volatile struct time *p_time, uint8_t sw_edit, uint8_t minutes)
+{
+  // when minute is pressed add the step, 10 minute steps skip the one minutes.
+  if(sw_edit & SW_MINUTE)
+  {
+    if(minutes == 10)
+    {
+      p_time->ten_minutes++;
+    }
+    else
+    {
+      p_time->one_minutes++;
+    }
+  }
+
+  // when hour is pressed add one
+  p_time->one_hours += ((sw_edit & SW_HOUR) ? 1 : 0);
+
+  // the below is the same code used in the minute task. copy pasta with tweaks, minutes do not carry into hours.
+  if(p_time->one_minutes > 9)
+  {
+    p_time->ten_minutes++;
+    p_time->one_minutes = 0;
+  }
+
+  if(p_time->ten_minutes > 5)
+  {
+    p_time->ten_minutes = 0;
+  }
+
+  if(p_time->one_hours > 9)
+  {
+    p_time->ten_hours++;
+    p_time->one_hours = 0;
+  }
+
+  if((p_time->ten_hours >= 2) && (p_time->one_hours >= 4))
+  {
+    p_time->ten_hours = 0;
+    p_time->one_hours = 0;
+  }
+}
+
+// function to render a time struct into a frame of 7 segment values in digitArray order.
+void renderFrame(uint8_t *p_frame, volatile struct time *p_time)
+{
+  p_frame[0] = segmentArray[p_time->one_minutes];
+  p_frame[1] = segmentArray[p_time->ten_minutes];
+  p_frame[2] = segmentArray[p_time->one_hours];
+  p_frame[3] = segmentArray[p_time->ten_hours];
+}
+
+// function to render the shown isr timing stats page into a frame, the page number and a 3 digit value.
+void renderStats(uint8_t *p_frame)
+{
+  /// @brief local variable for the stat on the shown page, counted down into digits.
+  uint8_t value;
+  /// @brief local variable for the digit being counted.
+  uint8_t digit = 0;
+
+  value = ((statsPage == 1) ? maxLatency : ((statsPage == 2) ? overrunCount : preemptCount));
+
+  p_frame[3] = segmentArray[statsPage];
+
+  // split the value into digits by subtraction, there is no divide on the 8051 and it is at most 255.
+  while(value >= 100)
+  {
+    value -= 100;
+    digit++;
+  }
+
+  p_frame[2] = segmentArray[digit];
+  digit = 0;
+
+  while(value >= 10)
+  {
+    value -= 10;
+    digit++;
+  }
+
+  p_frame[1] = segmentArray[digit];
+  p_frame[0] = segmentArray[value];
+}
+
+// function to render the date or year into a frame.
+void renderDate(uint8_t *p_frame)
+{
+  if(timeShow == SHOW_YEAR)
+  {
+    p_frame[3] = segmentArray[2];
+    p_frame[2] = segmentArray[0];
+    renderTwo(p_frame, gs_date.year);
+  }
+  else
+  {
+    // day on the hour digits, month on the minute digits.
+    renderTwo(&p_frame[2], gs_date.day);
+    renderTwo(p_frame, gs_date.month);
+  }
+}
+
+// function to render a value from 0 to 99 into two digits of a frame, ones first.
+void renderTwo(uint8_t *p_digits, uint8_t value)
+{
+  /// @brief local variable for the tens digit being counted.
+  uint8_t digit = 0;
+
+  // split by subtraction, there is no divide on the 8051.
+  while(value >= 10)
+  {
+    value -= 10;
+    digit++;
+  }
+
+  p_digits[1] = segmentArray[digit];
+  p_digits[0] = segmentArray[value];
+}
+
+// function to get the days in a month of the current year.
+uint8_t monthDays(uint8_t month)
+{
+  // from 2000 to 2099 every 4th year is a leap year, no divide needed.
+  return monthArray[month] + (((month == 2) && !(gs_date.year & 0x03)) ? 1 : 0);
+}
+
+// function to find the weekday of a day of a month in the current year.
+uint8_t findWeekday(uint8_t month, uint8_t day)
+{
+  /// @brief local variable for the month being counted.
+  uint8_t index;
+  /// @brief local variable for the weekday, 1 January 2000 was a Saturday. A year is 52 weeks and a day, each leap year before this one adds a day more.
+  uint8_t weekday = 5 + gs_date.year + ((gs_date.year + 3) >> 2);
+
+  // a month is 4 weeks and the days past 28.
+  for(index = 1; index < month; index++)
+  {
+    weekday += monthDays(index) - 28;
+  }
+
+  weekday += day - 1;
+
+  while(weekday >= 7)
+  {
+    weekday -= 7;
+  }
+
+  return weekday;
+}
+
+// function to move the date on to the next day, at midnight.
+void nextDay(void)
+{
+  gs_date.weekday = ((gs_date.weekday >= 6) ? 0 : gs_date.weekday + 1);
+
+  // once past the end of the month, move on to the 1st of the next.
+  if(++gs_date.day > monthDays(gs_date.month))
+  {
+    gs_date.day = 1;
+
+    // once past December, move on to January of the next year.
+    if(++gs_date.month > 12)
+    {
+      gs_date.month = 1;
+      gs_date.year  = ((gs_date.year >= 99) ? 0 : gs_date.year + 1);
+    }
+  }
+
+  findTransition();
+}
+
+// function to step the date by a month and/or by a day, for setting the date.
+void editDate(uint8_t sw_edit)
+{
+  // hour steps the month, past December the year moves on.
+  if(sw_edit & SW_HOUR)
+  {
+    if(++gs_date.month > 12)
+    {
+      gs_date.month = 1;
+      gs_date.year  = ((gs_date.year >= 99) ? 0 : gs_date.year + 1);
+    }
+
+    // the new month may be shorter.
+    if(gs_date.day > monthDays(gs_date.month))
+    {
+      gs_date.day = monthDays(gs_date.month);
+    }
+  }
+
+  // minute steps the day, past the end of the month it starts over.
+  if(sw_edit & SW_MINUTE)
+  {
+    gs_date.day = ((gs_date.day >= monthDays(gs_date.month)) ? 1 : gs_date.day + 1);
+  }
+
+  gs_date.weekday = findWeekday(gs_date.month, gs_date.day);
+  date_set        = ON;
+
+  findSeason();
+  findTransition();
+}
+
+// function to find the day of the month a daylight saving rule falls on in the current year.
+uint8_t ruleDay(uint8_t rule)
+{
+  /// @brief local variable for the week of the rule still to count.
+  uint8_t week = dstArray[rule].week;
+  /// @brief local variable for the day, first the first of the rule's weekday in the month.
+  uint8_t day = dstArray[rule].weekday + 8 - findWeekday(dstArray[rule].month, 1);
+
+  if(day > 7)
+  {
+    day -= 7;
+  }
+
+  // a week on for each week of the rule, DST_LAST stops at the last one in the month.
+  while((--week) && ((day + 7) <= monthDays(dstArray[rule].month)))
+  {
+    day += 7;
+  }
+
+  return day;
+}
+
+// function to set dst_on from the daylight saving rules that have passed this year, for when the date is set.
+void findSeason(void)
+{
+  /// @brief local variable for the rule being checked, index into dstArray.
+  uint8_t rule;
+
+  dst_on = OFF;
+
+  // before this year's first rule the last rule of last year is in effect.
+  for(rule = dstSetArray[DST_RULES]; dstArray[rule].month; rule++)
+  {
+    dst_on = dstArray[rule].forward;
+  }
+
+  for(rule = dstSetArray[DST_RULES]; dstArray[rule].month; rule++)
+  {
+    // rules in later months have not passed, in this month it depends on the day and minute.
+    if(dstArray[rule].month > gs_date.month)
+    {
+      break;
+    }
+
+    if(dstArray[rule].month == gs_date.month)
+    {
+      /// @brief local variable for the day the rule falls on.
+      uint8_t day = ruleDay(rule);
+
+      if((day > gs_date.day) || ((day == gs_date.day) && (minuteOfDay < dstArray[rule].minute)))
+      {
+        break;
+      }
+    }
+
+    dst_on = dstArray[rule].forward;
+  }
+}
+
+// function to find today's daylight saving shift and store it in dstMinute, once a day and when the time or date is set.
+void findTransition(void)
+{
+  /// @brief local variable for the rule being checked, index into dstArray.
+  uint8_t rule;
+
+  dstMinute = NO_ALARM;
+
+  // the date after a cold start is 1 January 2000, rule days counted from it would shift the clock on a random real day.
+  if(date_set == OFF)
+  {
+    return;
+  }
+
+  // only a rule that changes dst_on counts, so a shift back does not repeat when its hour comes round again.
+  for(rule = dstSetArray[DST_RULES]; dstArray[rule].month; rule++)
+  {
+    if((dstArray[rule].month == gs_date.month) && (dstArray[rule].forward != dst_on) && (minuteOfDay < dstArray[rule].minute) && (ruleDay(rule) == gs_date.day))
+    {
+      dstMinute = dstArray[rule].minute;
+    }
+  }
+}
+
+// function to move the time an hour on or back at the daylight saving shift.
+void shiftHour(void)
+{
+  dst_on    = !dst_on;
+  dstMinute = NO_ALARM;
+
+  if(dst_on)
+  {
+    editTime(&gs_timeKeeper, SW_HOUR, 1);
+  }
+  // back an hour, rules never shift across midnight.
+  else if(gs_timeKeeper.one_hours > 0)
+  {
+    gs_timeKeeper.one_hours--;
+  }
+  else
+  {
+    gs_timeKeeper.ten_hours--;
+    gs_timeKeeper.one_hours = 9;
+  }
+
+  minuteOfDay = toMinutes(&gs_timeKeeper);
+
+  // the next alarm depends on the new minute of the day.
+  alarm_changed = ON;
+}
+
+/// @brief control_isr is a interrupt function for the millisecond tick timer (timer 0, or timer 2 on the 89s52) when a over flow occurs. Only sets the tick and scan events, the work is done by the tasks in main.
+///        Uses register bank 1 so its registers are not saved on each entry, the low priority switch isrs share it since they can not preempt it.
+void control_isr (void) __interrupt (TICK_VECTOR) CONTROL_USING
+{
+  /// @brief local variable for the microseconds from the timer overflow to here.
+  uint8_t latency;
+
+  PROFILE_ON(PROFILE_CONTROL);
+
+  control_busy = ON;
+
+#ifdef TARGET_AT89S52
+  // timer 2 reloads to TL0_START on overflow and keeps counting, the counts past it are the latency.
+  latency = ((TH2 != TH0_START) ? 0xFF : TL2 - TL0_START);
+#else
+  // timer 0 rolls over to 0 and keeps counting till it is reloaded, the counts since are the latency.
+  latency = (TH0 ? 0xFF : TL0);
+#endif
+
+  if(latency > maxLatency)
+  {
+    maxLatency = latency;
+  }
+
+#ifdef TARGET_AT89S52
+  // reset timer overflow, timer 2 does not clear it in hardware. The counters reload themselves.
+  TF2 = 0;
+#else
+  // reset timer overflow, though it does this anyways.
+  TF0 = 0;
+
+  // reset timer counters start point.
+  TH0 = TH0_START;
+  TL0 = TL0_START;
+#endif
+
+  tick_ready = ON;
+
+  // count down to the next scan, which also moves the timer wheel.
+  if(++scanTimeout >= SCAN_TIME)
+  {
+    scanTimeout = 0;
+    scan_ready  = ON;
+  }
+
+  // the tick timer overflowed again before the isr finished, a tick was lost.
+#ifdef TARGET_AT89S52
+  if(TF2 && (overrunCount != 0xFF))
+#else
+  if(TF0 && (overrunCount != 0xFF))
+#endif
+  {
+    overrunCount++;
+  }
+
+  control_busy = OFF;
+
+  PROFILE_OFF(PROFILE_CONTROL);
+}
+
+/// @brief Keep track of time in seconds as precisely as possible, the minute task in main keeps the rest of the time. Uses register bank 2 on the AT89S52, it is the only high priority isr and can preempt bank 1.
+void timer_isr (void) __interrupt (TF1_VECTOR) TIMER_USING
+{
+  PROFILE_ON(PROFILE_TIMER);
+
+  // reset timer overflow, though it does this anyways.
+  TF1 = 0;
+
+  // reset timer counters start point.
+  TH1 = TH1_START;
+  TL1 = TL1_START;
+
+  // count the times this isr got in while the control isr was running.
+  if(control_busy && (preemptCount != 0xFF))
+  {
+    preemptCount++;
+  }
+
+  // tell main a second passed, also while held.
+  second_changed = ON;
+
+  // check if the time set switch is pressed on its own. If so keep seconds at 0 and hold. While the date is being set the seconds keep going, also once alarm set is let go first.
+  if(!SET_T_SWITCH && SET_A_SWITCH && !date_edit)
+  {
+    seconds = 0;
+    PROFILE_OFF(PROFILE_TIMER);
+    return;
+  }
+
+  // increment seconds on each timer overflow, once over 59 tell main a minute has passed and reset seconds.
+  if(++seconds > 59)
+  {
+    seconds        = 0;
+    minute_changed = ON;
+  }
+
+  PROFILE_OFF(PROFILE_TIMER);
+}
+
+/// @brief alarm_switch_isr is a interrupt function for INT0 on the alarm on/off switch falling edge. Tells main to start a switch scan burst.
+void alarm_switch_isr (void) __interrupt (IE0_VECTOR) CONTROL_USING
+{
+  input_ready = ON;
+}
+
+/// @brief time_switch_isr is a interrupt function for INT1 on the time set switch falling edge. Tells main to start a switch scan burst.
+void time_switch_isr (void) __interrupt (IE1_VECTOR) CONTROL_USING
+{
+  input_ready = ON;
 }